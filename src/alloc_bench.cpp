@@ -0,0 +1,377 @@
+#include "alloc_bench.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static const size_t kBatch = 256;
+static const size_t kSizeTable = 4096;
+static const uint32_t kMinSize = 16;
+static const uint32_t kMaxSize = 64 * 1024;
+
+using Sizes = std::vector<uint32_t>;
+
+/*
+** Allocators under test. They share one duck-typed interface so the workers
+** can be templated on them and the comparison is not skewed by an indirect
+** call: alloc(n), free(p, n), release_all() at the end of each batch, and,
+** when kCrossThreadFree is set, free_remote(p, n) for a block allocated by this
+** instance but freed on another thread.
+*/
+struct MallocAlloc {
+    static constexpr bool kCrossThreadFree = true;
+    void *alloc(size_t n) { return std::malloc(n); }
+    void free(void *p, size_t) { std::free(p); }
+    void free_remote(void *p, size_t) { std::free(p); }
+    void release_all() {}
+};
+
+struct NewAlloc {
+    static constexpr bool kCrossThreadFree = true;
+    void *alloc(size_t n) { return ::operator new(n); }
+    void free(void *p, size_t) { ::operator delete(p); }
+    void free_remote(void *p, size_t) { ::operator delete(p); }
+    void release_all() {}
+};
+
+/* Bump allocator over 1 MiB chunks; memory is reclaimed only by release_all. */
+class ArenaAlloc {
+    static const size_t kChunk = 1 << 20;
+    std::vector<char *> chunks_;
+    size_t cur_ = 0, off_ = 0;
+
+  public:
+    static constexpr bool kCrossThreadFree = false;
+
+    ArenaAlloc() { chunks_.push_back(static_cast<char *>(std::malloc(kChunk))); }
+    ArenaAlloc(const ArenaAlloc &) = delete;
+    ArenaAlloc &operator=(const ArenaAlloc &) = delete;
+    ~ArenaAlloc() {
+        for (char *c : chunks_)
+            std::free(c);
+    }
+
+    void *alloc(size_t n) {
+        n = (n + 15) & ~size_t(15);
+        if (off_ + n > kChunk) {
+            if (++cur_ == chunks_.size())
+                chunks_.push_back(static_cast<char *>(std::malloc(kChunk)));
+            off_ = 0;
+        }
+        void *p = chunks_[cur_] + off_;
+        off_ += n;
+        return p;
+    }
+    void free(void *, size_t) {}
+    void release_all() { cur_ = off_ = 0; }
+};
+
+/*
+** Per-thread power-of-two size classes (16 B .. 64 KiB) with intrusive free
+** lists, refilled from 64 KiB slabs. A block freed on another thread is
+** pushed onto its owner's lock-free remote stack for that class; the owner
+** takes the whole stack in refill() before carving a new slab, so memory
+** handed to a consumer comes back instead of growing without bound. Only the
+** owner pops, and it takes every node at once, so the stack has no ABA issue.
+*/
+class PoolAlloc {
+    static const int kClasses = 13;
+    struct Node {
+        Node *next;
+    };
+    Node *free_[kClasses] = {};
+    std::atomic<Node *> remote_[kClasses] = {};
+    std::vector<void *> slabs_;
+
+    static int size_class(size_t n) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, (n - 1) | 15);
+        return static_cast<int>(idx) - 3;
+#else
+        return 60 - __builtin_clzll((n - 1) | 15);
+#endif
+    }
+
+    void refill(int c) {
+        free_[c] = remote_[c].exchange(nullptr, std::memory_order_acquire);
+        if (free_[c])
+            return;
+
+        const size_t sz = size_t(16) << c;
+        const size_t slab = std::max<size_t>(64 * 1024, sz * 4);
+        char *s = static_cast<char *>(std::malloc(slab));
+        slabs_.push_back(s);
+        for (size_t off = 0; off + sz <= slab; off += sz)
+            free(s + off, sz);
+    }
+
+  public:
+    static constexpr bool kCrossThreadFree = true;
+
+    PoolAlloc() = default;
+    PoolAlloc(const PoolAlloc &) = delete;
+    PoolAlloc &operator=(const PoolAlloc &) = delete;
+    ~PoolAlloc() {
+        for (void *s : slabs_)
+            std::free(s);
+    }
+
+    void *alloc(size_t n) {
+        int c = size_class(n);
+        if (!free_[c])
+            refill(c);
+        Node *p = free_[c];
+        free_[c] = p->next;
+        return p;
+    }
+    void free(void *p, size_t n) {
+        Node *q = static_cast<Node *>(p);
+        int c = size_class(n);
+        q->next = free_[c];
+        free_[c] = q;
+    }
+    void free_remote(void *p, size_t n) {
+        Node *q = static_cast<Node *>(p);
+        std::atomic<Node *> &head = remote_[size_class(n)];
+        q->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(q->next, q,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+    }
+    void release_all() {}
+};
+
+/* Start/stop barrier so the main thread times only the measured loops. */
+struct Gate {
+    std::atomic<unsigned> ready{0}, done{0};
+    std::atomic<bool> go{false}, release{false};
+
+    static void spin_until(const std::atomic<bool> &flag) {
+        while (!flag.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    void start() {
+        ready.fetch_add(1);
+        spin_until(go);
+    }
+    void finish() {
+        done.fetch_add(1);
+        spin_until(release);
+    }
+};
+
+/* Single-producer single-consumer ring for the cross-thread scenario. */
+struct Handoff {
+    static const size_t kCap = 4096;
+    struct Item {
+        void *p;
+        uint32_t n;
+    };
+    Item items[kCap];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+static size_t resident_bytes() {
+#ifdef __linux__
+    long pages = 0, resident = 0;
+    if (FILE *f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(f);
+    }
+    return static_cast<size_t>(resident) * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+static Sizes fixed_sizes(uint32_t n) { return Sizes(kSizeTable, n); }
+
+/* Bounded Pareto (alpha = 1.2) between 16 B and 64 KiB. */
+static Sizes powerlaw_sizes() {
+    Sizes v(kSizeTable);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> u(1e-9, 1.0);
+    for (auto &s : v) {
+        double x = kMinSize * std::pow(u(rng), -1.0 / 1.2);
+        s = static_cast<uint32_t>(std::min<double>(x, kMaxSize));
+    }
+    return v;
+}
+
+/*
+** Allocate a batch of kBatch blocks, touching each one, then free them all.
+** Touching makes first-use page faults part of the measured cost.
+*/
+template <typename A>
+static void churn(A &a, const Sizes &sizes, size_t ops) {
+    void *live[kBatch];
+    const size_t mask = sizes.size() - 1;
+    for (size_t i = 0; i < ops; i += kBatch) {
+        for (size_t j = 0; j < kBatch; j++) {
+            live[j] = a.alloc(sizes[(i + j) & mask]);
+            *static_cast<volatile char *>(live[j]) = 1;
+        }
+        for (size_t j = 0; j < kBatch; j++)
+            a.free(live[j], sizes[(i + j) & mask]);
+        a.release_all();
+    }
+}
+
+template <typename A>
+static void produce(A &a, Handoff &q, const Sizes &sizes, size_t ops) {
+    const size_t mask = sizes.size() - 1;
+    for (size_t i = 0; i < ops; i++) {
+        size_t t = q.tail.load(std::memory_order_relaxed);
+        while (t - q.head.load(std::memory_order_acquire) == Handoff::kCap)
+            std::this_thread::yield();
+        uint32_t n = sizes[i & mask];
+        void *p = a.alloc(n);
+        *static_cast<volatile char *>(p) = 1;
+        q.items[t % Handoff::kCap] = {p, n};
+        q.tail.store(t + 1, std::memory_order_release);
+    }
+}
+
+/* Frees into `owner`, the producer's allocator, from the consumer thread. */
+template <typename A> static void consume(A &owner, Handoff &q, size_t ops) {
+    for (size_t i = 0; i < ops; i++) {
+        size_t h = q.head.load(std::memory_order_relaxed);
+        while (q.tail.load(std::memory_order_acquire) == h)
+            std::this_thread::yield();
+        Handoff::Item it = q.items[h % Handoff::kCap];
+        owner.free_remote(it.p, it.n);
+        q.head.store(h + 1, std::memory_order_release);
+    }
+}
+
+/*
+** Runs work(tid, gate) on `threads` threads and fills the timing and RSS
+** columns of row. `pairs` is the total number of alloc/free pairs performed.
+*/
+template <typename Work>
+static void run_threads(unsigned threads, size_t pairs, Work work,
+                        AllocRow &row) {
+    Gate g;
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back([&, t]() { work(t, g); });
+
+    while (g.ready.load() != threads)
+        std::this_thread::yield();
+    size_t rss0 = resident_bytes();
+    auto t0 = std::chrono::steady_clock::now();
+    g.go.store(true, std::memory_order_release);
+    while (g.done.load() != threads)
+        std::this_thread::yield();
+    auto t1 = std::chrono::steady_clock::now();
+    size_t rss1 = resident_bytes();
+    g.release.store(true, std::memory_order_release);
+    for (auto &th : pool)
+        th.join();
+
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    row.available = true;
+    row.mops_per_sec = static_cast<double>(pairs) / secs / 1e6;
+    row.rss_growth_mib =
+        (static_cast<double>(rss1) - static_cast<double>(rss0)) / (1 << 20);
+}
+
+template <typename A>
+static void bench_allocator(const char *name, unsigned threads, size_t ops,
+                            const Sizes &fixed, const Sizes &power,
+                            std::vector<AllocRow> &rows) {
+    ops = (ops + kBatch - 1) / kBatch * kBatch;
+
+    const struct {
+        const char *scenario;
+        const Sizes *sizes;
+    } churns[] = {{"fixed32", &fixed}, {"powerlaw", &power}};
+    for (auto &c : churns) {
+        AllocRow row{c.scenario, name, threads};
+        run_threads(
+            threads, threads * ops,
+            [&](unsigned, Gate &g) {
+                A a;
+                g.start();
+                churn(a, *c.sizes, ops);
+                g.finish();
+            },
+            row);
+        rows.push_back(row);
+    }
+
+    /* Odd thread counts run (and are reported as) one thread fewer. */
+    const unsigned pairs = threads / 2;
+    AllocRow row{"xthread", name, pairs ? pairs * 2 : threads};
+    if constexpr (A::kCrossThreadFree) {
+        if (pairs > 0) {
+            std::unique_ptr<Handoff[]> queues(new Handoff[pairs]);
+            std::vector<std::unique_ptr<A>> owners;
+            for (unsigned p = 0; p < pairs; p++)
+                owners.emplace_back(new A);
+            run_threads(
+                pairs * 2, pairs * ops,
+                [&](unsigned tid, Gate &g) {
+                    A &owner = *owners[tid / 2];
+                    Handoff &q = queues[tid / 2];
+                    g.start();
+                    if (tid % 2 == 0)
+                        produce(owner, q, power, ops);
+                    else
+                        consume(owner, q, ops);
+                    g.finish();
+                },
+                row);
+        }
+    }
+    rows.push_back(row);
+}
+
+/**
+ * @brief Measures malloc, operator new, a bump arena and a size-class pool.
+ *
+ * Scenarios: fixed32 (32-byte blocks), powerlaw (16 B .. 64 KiB, Pareto
+ * distributed), both in batches of 256 allocations followed by 256 frees, and
+ * xthread (power-law blocks allocated by a producer and freed by a consumer
+ * thread; runs threads / 2 pairs, needs at least two threads and is
+ * unavailable for the arena).
+ *
+ * @param max_threads Largest thread count; powers of two below it are also run.
+ * @param ops Alloc/free pairs per thread (per producer for xthread).
+ * @return One AllocRow per (threads, allocator, scenario).
+ */
+std::vector<AllocRow> alloc_table(unsigned max_threads, size_t ops) {
+    const Sizes fixed = fixed_sizes(32);
+    const Sizes power = powerlaw_sizes();
+
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(std::max(max_threads, 1u));
+
+    std::vector<AllocRow> rows;
+    for (unsigned t : counts) {
+        bench_allocator<MallocAlloc>("malloc", t, ops, fixed, power, rows);
+        bench_allocator<NewAlloc>("new", t, ops, fixed, power, rows);
+        bench_allocator<ArenaAlloc>("arena", t, ops, fixed, power, rows);
+        bench_allocator<PoolAlloc>("pool", t, ops, fixed, power, rows);
+    }
+    return rows;
+}
@@ -0,0 +1,33 @@
+#ifndef ALLOC_BENCH_H_
+#define ALLOC_BENCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+** One measurement of the allocator module: `threads` workers each performing
+** `ops` allocate/free pairs of the given size distribution.
+*/
+struct AllocRow {
+    std::string scenario;  // fixed32, powerlaw, xthread
+    std::string allocator; // malloc, new, arena, pool
+    unsigned threads = 0;
+    bool available = false;
+    double mops_per_sec = 0.0;
+    /* Resident set growth over the run, before the allocators are torn down. */
+    double rss_growth_mib = 0.0;
+};
+
+/*
+** alloc_table(max_threads, ops) -> std::vector<AllocRow>
+**
+** Runs every scenario against every allocator at 1, 2, 4, ... max_threads
+** threads. malloc and new go through whatever allocator the process was
+** linked or LD_PRELOADed with, so rerunning under a different LD_PRELOAD
+** compares alternative allocators against the same arena and pool baselines.
+*/
+std::vector<AllocRow> alloc_table(unsigned max_threads, size_t ops);
+
+#endif // ALLOC_BENCH_H_
@@ -0,0 +1,375 @@
+#include "canary.hpp"
+#include "timing.hpp"
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+int CanaryHistogram::bucket_index(uint64_t v) {
+    if (v < (2u << kSubBits))
+        return static_cast<int>(v);
+#ifdef _MSC_VER
+    unsigned long msb;
+    _BitScanReverse64(&msb, v);
+    int shift = static_cast<int>(msb) - kSubBits;
+#else
+    int shift = 63 - __builtin_clzll(v) - kSubBits;
+#endif
+    if (shift > kMaxShift)
+        return kBuckets - 1;
+    return (shift << kSubBits) + static_cast<int>(v >> shift);
+}
+
+uint64_t CanaryHistogram::bucket_end(int i) {
+    if (i < (2 << kSubBits))
+        return static_cast<uint64_t>(i) + 1;
+    int shift = (i >> kSubBits) - 1;
+    uint64_t sub = (i & ((1 << kSubBits) - 1)) + (1u << kSubBits);
+    return (sub + 1) << shift;
+}
+
+/* Single writer: plain load/store instead of a locked read-modify-write. */
+static inline void bump(std::atomic<uint64_t> &a, uint64_t by) {
+    a.store(a.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+void CanaryHistogram::record(uint64_t v) {
+    bump(buckets[bucket_index(v)], 1);
+    bump(sum, v);
+    bump(count, 1);
+}
+
+uint64_t CanaryHistogram::quantile(double q) const {
+    uint64_t n = count.load(std::memory_order_relaxed);
+    if (n == 0)
+        return 0;
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(q * n));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return bucket_end(i) - 1;
+    }
+    return bucket_end(kBuckets - 1) - 1;
+}
+
+#ifdef __linux__
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory counters must be address-free atomics");
+
+static const char *const kProbeNames[CANARY_PROBES] = {"mem_chase", "fp_tput",
+                                                       "branch"};
+
+/*
+** Probe state that must persist between periods. The chase is one random
+** cycle over every cache line of the buffer; each probe continues from where
+** the previous one stopped, so a line is revisited only after
+** chase_bytes / 64 / 256 periods and is long gone from the caches by then.
+** That keeps the canary's own cache footprint per probe at 16 KiB.
+*/
+class CanaryProbes {
+    std::unique_ptr<size_t[]> chase_;
+    size_t cursor_ = 0;
+
+  public:
+    explicit CanaryProbes(size_t bytes) {
+        const size_t line = 64 / sizeof(size_t);
+        const size_t lines = std::max<size_t>(bytes / 64, 2);
+        chase_.reset(new size_t[lines * line]);
+        std::vector<size_t> order(lines);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+        for (size_t i = 0; i < lines; i++)
+            chase_[order[i] * line] = order[(i + 1) % lines] * line;
+        cursor_ = order[0] * line;
+    }
+
+    uint64_t mem_chase() {
+        size_t p = cursor_;
+        uint64_t t0 = tsc_start();
+        for (int i = 0; i < 256; i++) {
+            p = chase_[p];
+        }
+        uint64_t t1 = tsc_stop();
+        cursor_ = p;
+        return t1 - t0;
+    }
+
+    /*
+    ** Six independent multiply chains and six independent add chains. With
+    ** ~4-cycle latency on two FP ports, 8 operations in flight saturate the
+    ** units, so the 12 per iteration are issue-bound rather than waiting on a
+    ** dependency: a slower probe means a sibling is competing for the ports.
+    */
+    uint64_t fp_tput() {
+        double a0 = 1.0, a1 = 1.0, a2 = 1.0, a3 = 1.0, a4 = 1.0, a5 = 1.0;
+        double b0 = 1.0, b1 = 1.0, b2 = 1.0, b3 = 1.0, b4 = 1.0, b5 = 1.0;
+        const double m = 0.999999, c = 1e-6;
+        uint64_t t0 = tsc_start();
+        for (int i = 0; i < 512; i++) {
+            a0 *= m;
+            a1 *= m;
+            a2 *= m;
+            a3 *= m;
+            a4 *= m;
+            a5 *= m;
+            b0 += c;
+            b1 += c;
+            b2 += c;
+            b3 += c;
+            b4 += c;
+            b5 += c;
+            asm volatile(""
+                         : "+x"(a0), "+x"(a1), "+x"(a2), "+x"(a3), "+x"(a4),
+                           "+x"(a5), "+x"(b0), "+x"(b1), "+x"(b2), "+x"(b3),
+                           "+x"(b4), "+x"(b5));
+        }
+        uint64_t t1 = tsc_stop();
+        return t1 - t0;
+    }
+
+    /*
+    ** The branch direction comes from a fixed-seed xorshift, so the pattern is
+    ** identical each period and too long for the predictor to learn; more
+    ** mispredicts than usual mean a sibling thread is disturbing it.
+    */
+    uint64_t branch() {
+        uint32_t s = 2463534242u;
+        volatile int x = 0;
+        uint64_t t0 = tsc_start();
+        for (int i = 0; i < 4096; i++) {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            if (s & 1) {
+                x++;
+            }
+        }
+        uint64_t t1 = tsc_stop();
+        asm volatile("" ::"r"(x));
+        return t1 - t0;
+    }
+};
+
+static uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static void publish(CanaryShm &shm, uint32_t probe, uint64_t cycles) {
+    shm.hist[probe].record(cycles);
+
+    uint64_t idx = shm.head.load(std::memory_order_relaxed);
+    CanarySample &s = shm.ring[idx % shm.ring_slots];
+    s.seq.store(2 * idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.unix_ns.store(now_ns(CLOCK_REALTIME), std::memory_order_relaxed);
+    s.probe.store(probe, std::memory_order_relaxed);
+    s.cycles.store(cycles, std::memory_order_relaxed);
+    s.seq.store(2 * idx + 2, std::memory_order_release);
+    shm.head.store(idx + 1, std::memory_order_release);
+}
+
+/*
+** Writes the histograms in Prometheus text exposition format to a temporary
+** file next to path and renames it over path, so node_exporter never reads a
+** partial file. Bucket bounds are 2^k - 1, which are exact bucket edges.
+*/
+static void write_prom(const CanaryShm &shm, const std::string &path) {
+    std::string tmp = path + ".tmp";
+    FILE *f = std::fopen(tmp.c_str(), "w");
+    if (!f)
+        return;
+
+    std::fprintf(f, "# HELP mintime_canary_probe_cycles TSC cycles per canary "
+                    "probe (mem_chase: 256 loads, fp_tput: 3072 mul + 3072 "
+                    "add, branch: 4096 branches).\n"
+                    "# TYPE mintime_canary_probe_cycles histogram\n");
+    for (uint32_t p = 0; p < CANARY_PROBES; p++) {
+        const CanaryHistogram &h = shm.hist[p];
+        uint64_t cumulative = 0;
+        int i = 0;
+        for (int k = CanaryHistogram::kSubBits + 1;
+             k <= CanaryHistogram::kMaxShift + CanaryHistogram::kSubBits + 1;
+             k++) {
+            for (; i < CanaryHistogram::kBuckets &&
+                   CanaryHistogram::bucket_end(i) <= (1ull << k);
+                 i++)
+                cumulative += h.buckets[i].load(std::memory_order_relaxed);
+            std::fprintf(f,
+                         "mintime_canary_probe_cycles_bucket{probe=\"%s\","
+                         "le=\"%llu\"} %llu\n",
+                         kProbeNames[p], (1ull << k) - 1,
+                         static_cast<unsigned long long>(cumulative));
+        }
+        uint64_t n = h.count.load(std::memory_order_relaxed);
+        std::fprintf(f,
+                     "mintime_canary_probe_cycles_bucket{probe=\"%s\","
+                     "le=\"+Inf\"} %llu\n"
+                     "mintime_canary_probe_cycles_sum{probe=\"%s\"} %llu\n"
+                     "mintime_canary_probe_cycles_count{probe=\"%s\"} %llu\n",
+                     kProbeNames[p], static_cast<unsigned long long>(n),
+                     kProbeNames[p],
+                     static_cast<unsigned long long>(
+                         h.sum.load(std::memory_order_relaxed)),
+                     kProbeNames[p], static_cast<unsigned long long>(n));
+    }
+
+    std::fprintf(f, "# HELP mintime_canary_probe_cycles_quantile Quantiles of "
+                    "mintime_canary_probe_cycles since start.\n"
+                    "# TYPE mintime_canary_probe_cycles_quantile gauge\n");
+    for (uint32_t p = 0; p < CANARY_PROBES; p++) {
+        for (double q : {0.5, 0.99, 0.999})
+            std::fprintf(f,
+                         "mintime_canary_probe_cycles_quantile{probe=\"%s\","
+                         "quantile=\"%g\"} %llu\n",
+                         kProbeNames[p], q,
+                         static_cast<unsigned long long>(
+                             shm.hist[p].quantile(q)));
+    }
+
+    double busy = static_cast<double>(shm.busy_ns.load());
+    double elapsed = static_cast<double>(shm.elapsed_ns.load());
+    std::fprintf(f,
+                 "# HELP mintime_canary_duty_ratio Fraction of one core used "
+                 "by the canary since start.\n"
+                 "# TYPE mintime_canary_duty_ratio gauge\n"
+                 "mintime_canary_duty_ratio %g\n",
+                 elapsed > 0 ? busy / elapsed : 0.0);
+
+    bool ok = std::fflush(f) == 0;
+    ok = (std::fclose(f) == 0) && ok;
+    if (ok)
+        std::rename(tmp.c_str(), path.c_str());
+    else
+        std::remove(tmp.c_str());
+}
+
+/*
+** Maps the segment and takes it over as its only writer. A named segment stays
+** flock()ed through lock_fd for as long as the canary runs, so a second canary
+** on the same name fails here instead of interleaving head and the ring
+** sequence numbers with ours.
+*/
+static CanaryShm *map_shm(const std::string &name, int &lock_fd) {
+    lock_fd = -1;
+    void *p = MAP_FAILED;
+    if (name.empty()) {
+        p = mmap(nullptr, sizeof(CanaryShm), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0)
+            return nullptr;
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0 &&
+            ftruncate(fd, sizeof(CanaryShm)) == 0)
+            p = mmap(nullptr, sizeof(CanaryShm), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        lock_fd = fd;
+    }
+    if (p == MAP_FAILED)
+        return nullptr;
+
+    /*
+    ** The segment may already exist with a monitor mapping it. Retract magic
+    ** first so readers stop trusting it, clear everything behind it, and
+    ** publish magic again once the header is rewritten.
+    */
+    CanaryShm *shm = static_cast<CanaryShm *>(p);
+    shm->magic.store(0, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::memset(reinterpret_cast<char *>(shm) + sizeof(shm->magic), 0,
+                sizeof(CanaryShm) - sizeof(shm->magic));
+    shm->ring_slots = CanaryShm::kRingSlots;
+    shm->version = CanaryShm::kVersion;
+    shm->magic.store(CanaryShm::kMagic, std::memory_order_release);
+    return shm;
+}
+
+/**
+ * @brief Runs the canary probes at a bounded duty cycle until stop is set.
+ *
+ * Each period runs every probe once, publishes the samples, and then sleeps for
+ * the longer of the remaining period and the time needed to keep
+ * busy / elapsed at or below cfg.max_duty.
+ *
+ * @param cfg Period, duty bound and publication targets.
+ * @param stop Polled once per period and during sleeps.
+ * @return 0 on a clean stop, -1 if cfg is out of range or the shared-memory
+ * segment could not be mapped or is held by another canary.
+ */
+int run_canary(const CanaryConfig &cfg, const std::atomic<bool> &stop) {
+    /* Negated so NaN fails too; a day bounds the period_ns conversion. */
+    if (cfg.prom_every == 0 || !(cfg.max_duty > 0 && cfg.max_duty <= 1) ||
+        !(cfg.period_sec >= 0 && cfg.period_sec <= 86400))
+        return -1;
+
+    int lock_fd;
+    CanaryShm *shm = map_shm(cfg.shm_name, lock_fd);
+    if (!shm)
+        return -1;
+
+    CanaryProbes probes(cfg.chase_bytes);
+    const uint64_t period_ns = static_cast<uint64_t>(cfg.period_sec * 1e9);
+    const uint64_t start = now_ns(CLOCK_MONOTONIC);
+
+    for (unsigned n = 1; !stop.load(std::memory_order_relaxed); n++) {
+        uint64_t t0 = now_ns(CLOCK_MONOTONIC);
+        publish(*shm, CANARY_MEM_CHASE, probes.mem_chase());
+        publish(*shm, CANARY_FP_TPUT, probes.fp_tput());
+        publish(*shm, CANARY_BRANCH, probes.branch());
+        if (!cfg.prom_path.empty() && n % cfg.prom_every == 0)
+            write_prom(*shm, cfg.prom_path);
+        uint64_t busy = now_ns(CLOCK_MONOTONIC) - t0;
+
+        bump(shm->busy_ns, busy);
+        uint64_t sleep_ns = std::max<uint64_t>(
+            period_ns > busy ? period_ns - busy : 0,
+            static_cast<uint64_t>(busy * (1.0 / cfg.max_duty - 1.0)));
+
+        /* Sleep in slices of at most 100 ms so stop is honoured promptly. */
+        uint64_t wake = now_ns(CLOCK_MONOTONIC) + sleep_ns;
+        for (uint64_t t = now_ns(CLOCK_MONOTONIC);
+             t < wake && !stop.load(std::memory_order_relaxed);
+             t = now_ns(CLOCK_MONOTONIC))
+            std::this_thread::sleep_for(std::chrono::nanoseconds(
+                std::min<uint64_t>(wake - t, 100000000)));
+        shm->elapsed_ns.store(now_ns(CLOCK_MONOTONIC) - start,
+                              std::memory_order_relaxed);
+    }
+
+    if (!cfg.prom_path.empty())
+        write_prom(*shm, cfg.prom_path);
+    munmap(shm, sizeof(CanaryShm));
+    if (lock_fd >= 0)
+        close(lock_fd);
+    return 0;
+}
+
+#else
+
+int run_canary(const CanaryConfig &, const std::atomic<bool> &) { return -1; }
+
+#endif // __linux__
@@ -0,0 +1,111 @@
+#ifndef CANARY_H_
+#define CANARY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+** Continuous canary mode.
+**
+** A handful of short probes (a slice of a memory pointer chase, an FP
+** throughput kernel and an unpredictable branch kernel) run once per period,
+** with the sleep stretched so the canary never uses more than max_duty of one
+** core. Results are recorded in HDR-style histograms and published through a
+** shared-memory segment (histograms plus a ring of recent samples) and,
+** optionally, a Prometheus textfile for node_exporter.
+**
+** The shared-memory layout below is the reader-facing contract: a monitor maps
+** the segment read-only and reads it without taking any lock. It should check
+** magic == CanaryShm::kMagic both before and after copying data out, since a
+** restarting canary retracts magic while it resets the segment. The segment is
+** never shm_unlink()ed, so it survives canary restarts; remove it by hand
+** (rm /dev/shm/<name>) when retiring the canary. Linux only.
+*/
+
+enum CanaryProbe : uint32_t {
+    CANARY_MEM_CHASE = 0, // 256 dependent loads that miss the caches
+    CANARY_FP_TPUT,       // 3072 double muls + 3072 adds over 12 chains
+    CANARY_BRANCH,        // 4096 data-dependent, unpredictable branches
+    CANARY_PROBES
+};
+
+/*
+** Log-linear histogram in the style of HdrHistogram: values below 32 have a
+** bucket each, above that every power of two is split into 16 sub-buckets
+** (at most 6.25% relative error). Single writer; counters are relaxed atomics
+** so readers in other processes may sample them at any time.
+*/
+struct CanaryHistogram {
+    static const int kSubBits = 4;
+    static const int kMaxShift = 36;
+    static const int kBuckets = (kMaxShift + 2) << kSubBits;
+
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> buckets[kBuckets];
+
+    static int bucket_index(uint64_t v);
+    /* Smallest value that falls in the bucket after i. */
+    static uint64_t bucket_end(int i);
+
+    void record(uint64_t v);
+    /* Upper bound of the bucket holding the q-quantile, q in [0, 1]. */
+    uint64_t quantile(double q) const;
+};
+
+/*
+** One ring slot, guarded by a per-slot sequence lock: seq is odd while the
+** writer fills the slot and 2 * (index + 1) once sample `index` is complete.
+** A reader copies the fields and keeps them only if seq was the same even
+** value before and after.
+*/
+struct CanarySample {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> unix_ns;
+    std::atomic<uint64_t> probe;
+    std::atomic<uint64_t> cycles;
+};
+
+struct CanaryShm {
+    static const uint64_t kMagic = 0x7972616e6163746dull; // "mtcanary"
+    static const uint32_t kVersion = 1;
+    static const uint32_t kRingSlots = 4096;
+
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t ring_slots;
+    /* Number of samples ever written; the newest is at (head - 1) % slots. */
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> busy_ns;
+    std::atomic<uint64_t> elapsed_ns;
+    CanaryHistogram hist[CANARY_PROBES];
+    CanarySample ring[kRingSlots];
+};
+
+struct CanaryConfig {
+    /* POSIX shm name; empty keeps the segment private to this process. */
+    std::string shm_name = "/mintime_canary";
+    /* Prometheus textfile, rewritten atomically; empty disables it. */
+    std::string prom_path;
+    double period_sec = 1.0;
+    /* Upper bound on the fraction of one core the canary may use. */
+    double max_duty = 0.005;
+    /* Rewrite the textfile every this many periods. */
+    unsigned prom_every = 15;
+    /* Pointer-chase footprint; each probe touches only 256 lines of it. */
+    size_t chase_bytes = 32u << 20;
+};
+
+/*
+** run_canary(cfg, stop) -> int
+**
+** Runs until stop becomes true. Returns 0, or -1 if cfg is out of range
+** (prom_every == 0, max_duty outside (0, 1], period_sec outside [0, 86400]),
+** the shared-memory segment could not be created, or another canary is already
+** writing to it. Always -1 outside Linux.
+*/
+int run_canary(const CanaryConfig &cfg, const std::atomic<bool> &stop);
+
+#endif // CANARY_H_
@@ -13,7 +13,9 @@
  * @param function_id The ID of the function to be executed by the CPUID
  * instruction.
  */
-void cpuid(int cpuInfo[4], int function_id) { __cpuid(cpuInfo, function_id); }
+static void cpuid(int cpuInfo[4], int function_id) {
+    __cpuid(cpuInfo, function_id);
+}
 /**
  * @brief A wrapper for the __cpuidex intrinsic function.
  *
@@ -25,7 +27,7 @@ void cpuid(int cpuInfo[4], int function_id) { __cpuid(cpuInfo, function_id); }
  * instruction.
  * @param subleaf The subleaf to be executed by the CPUID instruction.
  */
-void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
+static void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
     __cpuidex(cpuInfo, function_id, subleaf);
 }
 #elif defined(__GNUC__) || defined(__clang__)
@@ -40,7 +42,7 @@ void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
  * @param function_id The ID of the function to be executed by the CPUID
  * instruction.
  */
-void cpuid(int cpuInfo[4], int function_id) {
+static void cpuid(int cpuInfo[4], int function_id) {
     __cpuid(function_id, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
 }
 /**
@@ -54,7 +56,7 @@ void cpuid(int cpuInfo[4], int function_id) {
  * instruction.
  * @param subleaf The subleaf to be executed by the CPUID instruction.
  */
-void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
+static void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
     __cpuid_count(function_id, subleaf, cpuInfo[0], cpuInfo[1], cpuInfo[2],
                   cpuInfo[3]);
 }
@@ -66,7 +68,8 @@ void cpuidex(int cpuInfo[4], int function_id, int subleaf) {
  * @brief Retrieves information about the CPU.
  *
  * This function parses the CPUID registers to get the model, vendor, family,
- * and brand of the CPU. It uses either <cpuid.h> (on Linux) or <intrin.h> (on
+ * brand and the integer ISA extensions (SSE4.2, POPCNT, LZCNT, BMI1/2) of the
+ * CPU. It uses either <cpuid.h> (on Linux) or <intrin.h> (on
  * Windows) to get the CPU info.
  *
  * @return A CPUInfo struct containing the CPU's vendor, family, model, and
@@ -85,8 +88,12 @@ CPUInfo get_cpu_info() {
     vendor[12] = '\0';
     info.vendor = vendor;
 
+    unsigned max_leaf = regs[0];
+
     cpuid(regs, 1);
     unsigned eax = regs[0];
+    info.has_sse42 = (regs[2] >> 20) & 1;
+    info.has_popcnt = (regs[2] >> 23) & 1;
     unsigned base_family = (eax >> 8) & 0xF;
     unsigned base_model = (eax >> 4) & 0xF;
     unsigned ext_family = (eax >> 20) & 0xFF;
@@ -95,10 +102,22 @@ CPUInfo get_cpu_info() {
     info.family = (base_family == 0xF) ? base_family + ext_family : base_family;
     info.model = (ext_model << 4) | base_model;
 
+    // Structured extended features
+    if (max_leaf >= 7) {
+        cpuidex(regs, 7, 0);
+        info.has_bmi1 = (regs[1] >> 3) & 1;
+        info.has_bmi2 = (regs[1] >> 8) & 1;
+    }
+
     // Brand string
     char brand[0x40] = {};
     cpuid(regs, 0x80000000);
-    if ((unsigned)regs[0] >= 0x80000004) {
+    unsigned max_ext_leaf = regs[0];
+    if (max_ext_leaf >= 0x80000001) {
+        cpuid(regs, 0x80000001);
+        info.has_lzcnt = (regs[2] >> 5) & 1;
+    }
+    if (max_ext_leaf >= 0x80000004) {
         int *brand_int = (int *)brand;
         cpuid(&brand_int[0], 0x80000002);
         cpuid(&brand_int[4], 0x80000003);
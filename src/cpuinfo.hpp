@@ -6,6 +6,8 @@ struct CPUInfo {
     std::string vendor;
     unsigned family = 0, model = 0;
     std::string brand;
+    bool has_sse42 = false, has_popcnt = false, has_lzcnt = false;
+    bool has_bmi1 = false, has_bmi2 = false;
 };
 struct MachineProfile {
     bool has_slow_subnormals;
@@ -0,0 +1,278 @@
+#include "int_ops.hpp"
+#include "timing.hpp"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/*
+** The kernels are written in inline asm so the compiler can neither fold the
+** operations (division by a constant, popcount of a known value) nor pick a
+** different instruction. Every loop iteration issues eight instances.
+**
+** Latency kernels feed each result into the next instruction. Throughput
+** kernels use eight independent registers, or a renamed mov for the fixed
+** register forms (div, mul), so only the issue rate limits them.
+*/
+#define REP8(s) s s s s s s s s
+
+/*
+** div/idiv: the dividend is an all-ones value n, so (n / d) | n == n and the
+** chain keeps dividing the same operands. Each link is a div plus one `or`;
+** int_op_table() subtracts a measured `or` chain from the latency figure.
+** edx is cleared with a zero idiom rather than cqo, which would add a
+** dependency on rax; all dividends are positive.
+*/
+#define DIV_KERNELS(name, DIV, W)                                              \
+    static uint64_t lat_##name(uint64_t n, uint64_t d, unsigned loops) {       \
+        uint64_t x = n, r;                                                     \
+        uint64_t t0 = tsc_start();                                             \
+        for (unsigned i = 0; i < loops; i++) {                                 \
+            asm volatile(REP8("xor %%edx, %%edx\n\t" DIV " %" W "[d]\n\t"      \
+                              "or %" W "[n], %" W "[x]\n\t")                   \
+                         : [x] "+a"(x), "=&d"(r)                               \
+                         : [d] "r"(d), [n] "r"(n));                            \
+        }                                                                      \
+        return tsc_stop() - t0;                                                \
+    }                                                                          \
+    static uint64_t tput_##name(uint64_t n, uint64_t d, unsigned loops) {      \
+        uint64_t x, r;                                                         \
+        uint64_t t0 = tsc_start();                                             \
+        for (unsigned i = 0; i < loops; i++) {                                 \
+            asm volatile(REP8("mov %" W "[n], %" W "[x]\n\t"                   \
+                              "xor %%edx, %%edx\n\t" DIV " %" W "[d]\n\t")     \
+                         : [x] "=&a"(x), "=&d"(r)                              \
+                         : [d] "r"(d), [n] "r"(n));                            \
+        }                                                                      \
+        return tsc_stop() - t0;                                                \
+    }
+
+DIV_KERNELS(div32, "div", "k")
+DIV_KERNELS(div64, "div", "")
+DIV_KERNELS(idiv32, "idiv", "k")
+DIV_KERNELS(idiv64, "idiv", "")
+
+/* The `or` that links the div chains, timed alone so it can be subtracted. */
+static uint64_t lat_or64(uint64_t n, unsigned loops) {
+    uint64_t x = n;
+    uint64_t t0 = tsc_start();
+    for (unsigned i = 0; i < loops; i++) {
+        asm volatile(REP8("or %1, %0\n\t") : "+r"(x) : "r"(n));
+    }
+    return tsc_stop() - t0;
+}
+
+/*
+** Register-to-register ops. OP(x, y) expands to one instruction that reads and
+** writes x and reads y. The chain value p0 and operand p1 are chosen so the
+** value stays in range (imul by 1, pdep/pext under an all-ones mask).
+*/
+#define REG_KERNELS(name, OP, W)                                               \
+    static uint64_t lat_##name(uint64_t p0, uint64_t p1, unsigned loops) {     \
+        uint64_t x = p0;                                                       \
+        uint64_t t0 = tsc_start();                                             \
+        for (unsigned i = 0; i < loops; i++) {                                 \
+            asm volatile(REP8(OP("%" W "0", "%" W "1")) : "+r"(x) : "r"(p1));  \
+        }                                                                      \
+        return tsc_stop() - t0;                                                \
+    }                                                                          \
+    static uint64_t tput_##name(uint64_t p0, uint64_t p1, unsigned loops) {    \
+        uint64_t x0 = p0, x1 = p0, x2 = p0, x3 = p0;                           \
+        uint64_t x4 = p0, x5 = p0, x6 = p0, x7 = p0;                           \
+        uint64_t t0 = tsc_start();                                             \
+        for (unsigned i = 0; i < loops; i++) {                                 \
+            asm volatile(OP("%" W "0", "%" W "8") OP("%" W "1", "%" W "8")     \
+                             OP("%" W "2", "%" W "8") OP("%" W "3", "%" W "8") \
+                                 OP("%" W "4", "%" W "8")                      \
+                                     OP("%" W "5", "%" W "8")                  \
+                                         OP("%" W "6", "%" W "8")              \
+                                             OP("%" W "7", "%" W "8")          \
+                         : "+r"(x0), "+r"(x1), "+r"(x2), "+r"(x3), "+r"(x4),   \
+                           "+r"(x5), "+r"(x6), "+r"(x7)                        \
+                         : "r"(p1));                                           \
+        }                                                                      \
+        return tsc_stop() - t0;                                                \
+    }
+
+#define OP_IMUL(x, y) "imul " y ", " x "\n\t"
+#define OP_POPCNT(x, y) "popcnt " x ", " x "\n\t"
+#define OP_LZCNT(x, y) "lzcnt " x ", " x "\n\t"
+#define OP_TZCNT(x, y) "tzcnt " x ", " x "\n\t"
+#define OP_CRC32L(x, y) "crc32l " y ", " x "\n\t"
+#define OP_CRC32Q(x, y) "crc32q " y ", " x "\n\t"
+#define OP_PDEP(x, y) "pdep " y ", " x ", " x "\n\t"
+#define OP_PEXT(x, y) "pext " y ", " x ", " x "\n\t"
+
+REG_KERNELS(imul32, OP_IMUL, "k")
+REG_KERNELS(imul64, OP_IMUL, "")
+REG_KERNELS(popcnt64, OP_POPCNT, "")
+REG_KERNELS(lzcnt64, OP_LZCNT, "")
+REG_KERNELS(tzcnt64, OP_TZCNT, "")
+REG_KERNELS(crc32_32, OP_CRC32L, "k")
+REG_KERNELS(crc32_64, OP_CRC32Q, "")
+REG_KERNELS(pdep64, OP_PDEP, "")
+REG_KERNELS(pext64, OP_PEXT, "")
+
+/* One-operand widening mul: rdx:rax = rax * y, with y == 1. */
+static uint64_t lat_mul64(uint64_t p0, uint64_t p1, unsigned loops) {
+    uint64_t x = p0, hi;
+    uint64_t t0 = tsc_start();
+    for (unsigned i = 0; i < loops; i++) {
+        asm volatile(REP8("mulq %[y]\n\t")
+                     : "+a"(x), "=&d"(hi)
+                     : [y] "r"(p1));
+    }
+    return tsc_stop() - t0;
+}
+
+static uint64_t tput_mul64(uint64_t p0, uint64_t p1, unsigned loops) {
+    uint64_t x, hi;
+    uint64_t t0 = tsc_start();
+    for (unsigned i = 0; i < loops; i++) {
+        asm volatile(REP8("mov %[p], %%rax\n\t"
+                          "mulq %[y]\n\t")
+                     : "=&a"(x), "=&d"(hi)
+                     : [p] "r"(p0), [y] "r"(p1));
+    }
+    return tsc_stop() - t0;
+}
+
+/* mulx takes its first source from rdx; the chain runs through the low half. */
+static uint64_t lat_mulx64(uint64_t p0, uint64_t p1, unsigned loops) {
+    uint64_t x = p0, hi;
+    uint64_t t0 = tsc_start();
+    for (unsigned i = 0; i < loops; i++) {
+        asm volatile(REP8("mulx %[y], %[x], %[hi]\n\t")
+                     : [x] "+d"(x), [hi] "=&r"(hi)
+                     : [y] "r"(p1));
+    }
+    return tsc_stop() - t0;
+}
+
+#define OP_MULX(lo, hi) "mulx %[y], " lo ", " hi "\n\t"
+
+static uint64_t tput_mulx64(uint64_t p0, uint64_t p1, unsigned loops) {
+    uint64_t l0, h0, l1, h1, l2, h2, l3, h3;
+    uint64_t t0 = tsc_start();
+    for (unsigned i = 0; i < loops; i++) {
+        asm volatile(OP_MULX("%0", "%1") OP_MULX("%2", "%3")
+                         OP_MULX("%4", "%5") OP_MULX("%6", "%7")
+                             OP_MULX("%0", "%1") OP_MULX("%2", "%3")
+                                 OP_MULX("%4", "%5") OP_MULX("%6", "%7")
+                     : "=&r"(l0), "=&r"(h0), "=&r"(l1), "=&r"(h1), "=&r"(l2),
+                       "=&r"(h2), "=&r"(l3), "=&r"(h3)
+                     : [y] "r"(p1), "d"(p0));
+    }
+    return tsc_stop() - t0;
+}
+
+struct IntOp {
+    const char *instr;
+    const char *variant;
+    bool CPUInfo::*needs; // nullptr: baseline x86-64
+    uint64_t p0, p1;
+    uint64_t (*lat)(uint64_t, uint64_t, unsigned);
+    uint64_t (*tput)(uint64_t, uint64_t, unsigned);
+    bool or_in_chain = false; // lat links each result through an `or`
+};
+
+static const uint64_t kOnes64 = ~0ull;
+static const uint64_t kSparse = 0x0101010101010101ull;
+
+static const IntOp kIntOps[] = {
+    {"div r32", "n=2^8-1 d=3", nullptr, 0xFF, 3, lat_div32, tput_div32, true},
+    {"div r32", "n=2^32-1 d=3", nullptr, 0xFFFFFFFF, 3, lat_div32,
+     tput_div32, true},
+    {"div r64", "n=2^8-1 d=3", nullptr, 0xFF, 3, lat_div64, tput_div64, true},
+    {"div r64", "n=2^32-1 d=3", nullptr, 0xFFFFFFFF, 3, lat_div64,
+     tput_div64, true},
+    {"div r64", "n=2^64-1 d=3", nullptr, kOnes64, 3, lat_div64,
+     tput_div64, true},
+    {"div r64", "n=2^64-1 d=2^63-1", nullptr, kOnes64, kOnes64 >> 1,
+     lat_div64, tput_div64, true},
+    {"idiv r32", "n=2^7-1 d=3", nullptr, 0x7F, 3, lat_idiv32,
+     tput_idiv32, true},
+    {"idiv r32", "n=2^31-1 d=3", nullptr, 0x7FFFFFFF, 3, lat_idiv32,
+     tput_idiv32, true},
+    {"idiv r64", "n=2^7-1 d=3", nullptr, 0x7F, 3, lat_idiv64,
+     tput_idiv64, true},
+    {"idiv r64", "n=2^31-1 d=3", nullptr, 0x7FFFFFFF, 3, lat_idiv64,
+     tput_idiv64, true},
+    {"idiv r64", "n=2^63-1 d=3", nullptr, kOnes64 >> 1, 3, lat_idiv64,
+     tput_idiv64, true},
+    {"imul r32", "", nullptr, 0x12345, 1, lat_imul32, tput_imul32},
+    {"imul r64", "", nullptr, 0x12345, 1, lat_imul64, tput_imul64},
+    {"mul r64", "rdx:rax", nullptr, 0x12345, 1, lat_mul64, tput_mul64},
+    {"mulx r64", "", &CPUInfo::has_bmi2, 0x12345, 1, lat_mulx64,
+     tput_mulx64},
+    {"popcnt r64", "", &CPUInfo::has_popcnt, kOnes64, 0, lat_popcnt64,
+     tput_popcnt64},
+    {"lzcnt r64", "", &CPUInfo::has_lzcnt, kOnes64, 0, lat_lzcnt64,
+     tput_lzcnt64},
+    {"tzcnt r64", "", &CPUInfo::has_bmi1, kOnes64, 0, lat_tzcnt64,
+     tput_tzcnt64},
+    {"crc32 r32", "", &CPUInfo::has_sse42, 0, 0x12345, lat_crc32_32,
+     tput_crc32_32},
+    {"crc32 r64", "", &CPUInfo::has_sse42, 0, 0x12345, lat_crc32_64,
+     tput_crc32_64},
+    {"pdep r64", "mask=2^64-1", &CPUInfo::has_bmi2, 0x12345, kOnes64,
+     lat_pdep64, tput_pdep64},
+    {"pdep r64", "mask=0x0101..01", &CPUInfo::has_bmi2, 0x12345, kSparse,
+     lat_pdep64, tput_pdep64},
+    {"pext r64", "mask=2^64-1", &CPUInfo::has_bmi2, 0x12345, kOnes64,
+     lat_pext64, tput_pext64},
+    {"pext r64", "mask=0x0101..01", &CPUInfo::has_bmi2, 0x12345, kSparse,
+     lat_pext64, tput_pext64},
+};
+
+template <typename F> static uint64_t median3(F &&f) {
+    uint64_t v[3] = {f(), f(), f()};
+    std::sort(v, v + 3);
+    return v[1];
+}
+
+/**
+ * @brief Measures latency and reciprocal throughput of the integer table.
+ *
+ * Each kernel (latency and throughput) runs once to warm up and is then timed
+ * three times; the median is reported in TSC cycles per instruction. The
+ * div/idiv latencies have a separately measured `or` chain subtracted.
+ *
+ * @param ci CPU information used to skip rows whose extension is missing.
+ * @param iters Instructions per timed run, rounded down to a multiple of 8.
+ * @return One IntOpRow per table entry, in table order.
+ */
+std::vector<IntOpRow> int_op_table(const CPUInfo &ci, unsigned iters) {
+    const unsigned loops = std::max(iters / 8, 1u);
+    const double n = static_cast<double>(loops) * 8;
+
+    (void)lat_or64(kOnes64, loops);
+    const double or_lat =
+        median3([&]() { return lat_or64(kOnes64, loops); }) / n;
+
+    std::vector<IntOpRow> rows;
+    for (const IntOp &op : kIntOps) {
+        IntOpRow row;
+        row.instr = op.instr;
+        row.variant = op.variant;
+        row.available = op.needs == nullptr || ci.*op.needs;
+        if (row.available) {
+            (void)op.lat(op.p0, op.p1, loops);
+            (void)op.tput(op.p0, op.p1, loops);
+            row.latency =
+                median3([&]() { return op.lat(op.p0, op.p1, loops); }) / n;
+            if (op.or_in_chain)
+                row.latency = std::max(row.latency - or_lat, 0.0);
+            row.rthroughput =
+                median3([&]() { return op.tput(op.p0, op.p1, loops); }) / n;
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+#else
+
+std::vector<IntOpRow> int_op_table(const CPUInfo &, unsigned) { return {}; }
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef INT_OPS_H_
+#define INT_OPS_H_
+
+#include "cpuinfo.hpp"
+#include <string>
+#include <vector>
+
+/*
+** One row of the integer instruction table. Both figures are TSC cycles per
+** instruction: latency from a dependent chain, throughput (reciprocal) from
+** eight independent copies per loop iteration. The div/idiv chains need an
+** `or` per link; its measured latency is subtracted, so latency is the
+** division alone.
+*/
+struct IntOpRow {
+    std::string instr;
+    std::string variant;
+    bool available = false;
+    double latency = 0.0;
+    double rthroughput = 0.0;
+};
+
+/*
+** int_op_table(ci, iters) -> std::vector<IntOpRow>
+**
+** Measures div/idiv, mul/imul/mulx, popcnt/lzcnt/tzcnt, crc32 and pdep/pext.
+** Rows whose CPUID feature bit is missing in ci are returned unmeasured with
+** available = false.
+*/
+std::vector<IntOpRow> int_op_table(const CPUInfo &ci, unsigned iters);
+
+#endif // INT_OPS_H_
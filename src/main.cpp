@@ -1,52 +1,140 @@
-#include "cpuinfo.hpp"
 #include "csv_logger.hpp"
-#include "operations.hpp"
-#include "scheduler.hpp"
-#include <algorithm>
+#include "mintime.hpp"
+#include <atomic>
+#include <csignal>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <thread>
 
-struct Measured {
-    uint64_t add_slow, add_fast, mul_slow, mul_fast;
-};
+#ifdef __linux__
+#include <dlfcn.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char **environ;
+#endif
 
 /**
- * @brief Probes the system to measure the performance of different arithmetic
- * operations.
+ * @brief Prints the integer instruction table produced by --int-table.
  *
- * This function calculates the median time taken for slow and fast addition and
- * multiplication.
+ * @param rows The rows returned by int_op_table().
+ */
+static void print_int_table(const std::vector<mintime::IntOpRow> &rows) {
+    std::printf("%-12s %-20s %10s %12s\n", "instr", "variant", "latency",
+                "rthroughput");
+    for (auto &r : rows) {
+        const char *variant = r.variant.empty() ? "-" : r.variant.c_str();
+        if (r.available)
+            std::printf("%-12s %-20s %10.2f %12.2f\n", r.instr.c_str(),
+                        variant, r.latency, r.rthroughput);
+        else
+            std::printf("%-12s %-20s %10s %12s\n", r.instr.c_str(), variant,
+                        "n/a", "n/a");
+    }
+}
+
+/**
+ * @brief Prints the allocator table produced by --alloc.
  *
- * @param a An unsigned integer used as input for the timed operations.
- * @param b An unsigned integer used as input for the timed operations.
- * @return A Measured struct containing the median times for the four
- * operations.
+ * @param rows The rows returned by alloc_table().
  */
-Measured probe(unsigned a, unsigned b) {
-    auto median = [](auto &&f) {
-        const int N = 9;
-        uint64_t v[N];
-        for (int i = 0; i < N; i++)
-            v[i] = f();
-        std::sort(v, v + N);
-        return v[N / 2];
-    };
-    Measured m{};
-    m.add_slow = median([&]() { return timed_add_subnormal(a, b); });
-    m.add_fast = median([&]() { return timed_add_normal(a, b); });
-    m.mul_slow = median([&]() { return timed_mul_subnormal(a, b); });
-    m.mul_fast = median([&]() { return timed_mul_normal(a, b); });
-    return m;
+static void print_alloc_table(const std::vector<mintime::AllocRow> &rows) {
+    const char *preload = std::getenv("LD_PRELOAD");
+    std::printf("# LD_PRELOAD=%s\n", preload ? preload : "");
+    std::printf("%-9s %-7s %7s %10s %12s\n", "scenario", "alloc", "threads",
+                "Mops/s", "rss_MiB");
+    for (auto &r : rows) {
+        if (r.available)
+            std::printf("%-9s %-7s %7u %10.2f %12.1f\n", r.scenario.c_str(),
+                        r.allocator.c_str(), r.threads, r.mops_per_sec,
+                        r.rss_growth_mib);
+        else
+            std::printf("%-9s %-7s %7u %10s %12s\n", r.scenario.c_str(),
+                        r.allocator.c_str(), r.threads, "n/a", "n/a");
+    }
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Reruns `self --alloc max_threads` with LD_PRELOAD set to lib.
+ *
+ * This is the hook for comparing alternative allocators (jemalloc, tcmalloc,
+ * mimalloc, ...): malloc and new in the child resolve to the preloaded library.
+ *
+ * @param self argv[0], passed through to the child.
+ * @param max_threads Passed through to the child.
+ * @param lib Shared library to preload.
+ * @return The child's exit status, or -1 if lib cannot be loaded or the child
+ * could not be started.
+ */
+static int run_with_preload(const char *self, const std::string &max_threads,
+                            const char *lib) {
+#ifdef __linux__
+    /*
+    ** ld.so only warns about a preload it cannot load and runs the child on
+    ** glibc anyway, which would mislabel the table; try loading it here first.
+    */
+    void *handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << dlerror() << "\n";
+        return -1;
+    }
+    dlclose(handle);
+
+    std::vector<std::string> env_storage;
+    for (char **e = environ; *e; ++e)
+        if (std::string(*e).rfind("LD_PRELOAD=", 0) != 0)
+            env_storage.push_back(*e);
+    env_storage.push_back(std::string("LD_PRELOAD=") + lib);
+
+    std::vector<char *> envp;
+    for (auto &s : env_storage)
+        envp.push_back(&s[0]);
+    envp.push_back(nullptr);
+
+    /* argv[0] may be a bare name resolved through PATH; spawn the real file. */
+    char exe[4096];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len <= 0)
+        return -1;
+    exe[len] = '\0';
+
+    std::string mode = "--alloc", threads = max_threads;
+    char *args[] = {const_cast<char *>(self), &mode[0], &threads[0], nullptr};
+
+    pid_t pid;
+    if (posix_spawn(&pid, exe, nullptr, nullptr, args, envp.data()) != 0)
+        return -1;
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#else
+    (void)self;
+    (void)max_threads;
+    (void)lib;
+    return -1;
+#endif
 }
 
+#ifdef __linux__
+static std::atomic<bool> canary_stop{false};
+
+static void on_canary_signal(int) { canary_stop.store(true); }
+#endif
+
 /**
  * @brief The main entry point of the program.
  *
  * This function parses command-line arguments, profiles the CPU, and runs a
  * series of timed operations. The results of the timed operations are logged to
- * a CSV file and printed to the console.
+ * a CSV file and printed to the console. With --int-table [iters] it prints
+ * the integer instruction latency/throughput table instead; with --alloc
+ * [max_threads] [preload.so ...] the allocator table, once in-process and once
+ * per preloaded library; on Linux, with --canary [prom_file] [period_sec] it
+ * runs the continuous canary until SIGINT/SIGTERM.
  *
  * @param argc The number of command-line arguments.
  * @param argv An array of command-line arguments.
@@ -54,64 +142,72 @@ Measured probe(unsigned a, unsigned b) {
  */
 auto main(int argc, char *argv[]) -> int {
 
+    if (argc >= 2 && std::string(argv[1]) == "--int-table") {
+        unsigned iters =
+            argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 1u << 20;
+        print_int_table(mintime::int_op_table(get_cpu_info(), iters));
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--alloc") {
+        unsigned max_threads = std::thread::hardware_concurrency();
+        if (argc >= 3)
+            max_threads = std::strtoul(argv[2], nullptr, 10);
+        print_alloc_table(mintime::alloc_table(max_threads, 1u << 20));
+        for (int i = 3; i < argc; i++) {
+            if (run_with_preload(argv[0], std::to_string(max_threads),
+                                 argv[i]) != 0)
+                std::cerr << "failed to run with LD_PRELOAD=" << argv[i]
+                          << "\n";
+        }
+        return 0;
+    }
+
+#ifdef __linux__
+    if (argc >= 2 && std::string(argv[1]) == "--canary") {
+        mintime::CanaryConfig cfg;
+        if (argc >= 3)
+            cfg.prom_path = argv[2];
+        if (argc >= 4) {
+            char *end;
+            cfg.period_sec = std::strtod(argv[3], &end);
+            if (end == argv[3] || *end != '\0' ||
+                !(cfg.period_sec >= 0 && cfg.period_sec <= 86400)) {
+                std::cerr << "period_sec must be a number in [0, 86400]\n";
+                return 1;
+            }
+        }
+        std::signal(SIGINT, on_canary_signal);
+        std::signal(SIGTERM, on_canary_signal);
+        if (mintime::run_canary(cfg, canary_stop) != 0) {
+            std::cerr << "failed to map shared memory " << cfg.shm_name
+                      << " (is another canary running?)\n";
+            return 1;
+        }
+        return 0;
+    }
+#endif
+
     unsigned a = 10, b = 20;
     if (argc >= 3) {
         a = std::strtoul(argv[1], nullptr, 10);
         b = std::strtoul(argv[2], nullptr, 10);
     }
 
-    auto m = probe(50, 50);
-    bool subnormals_help =
-        (m.add_slow > m.add_fast * 2) || (m.mul_slow > m.mul_fast * 2);
-    CPUInfo ci = get_cpu_info();
-    auto prof = profile_from_cpu(ci);
-
-    std::vector<TimedOperations> palette;
-
-    if (subnormals_help || prof.has_slow_subnormals) {
-        palette.push_back({"add_slow", [](unsigned x, unsigned y) {
-                               return timed_add_subnormal(x, y);
-                           }});
-        palette.push_back({"mul_slow", [](unsigned x, unsigned y) {
-                               return timed_mul_subnormal(x, y);
-                           }});
-        palette.push_back({"sub_slow", [](unsigned x, unsigned y) {
-                               return timed_sub_subnormal(x, y);
-                           }});
-    }
-    palette.push_back({"add_fast", [](unsigned x, unsigned y) {
-                           return timed_add_normal(x, y);
-                       }});
-    palette.push_back({"mul_fast", [](unsigned x, unsigned y) {
-                           return timed_mul_normal(x, y);
-                       }});
-    palette.push_back({"sub_fast", [](unsigned x, unsigned y) {
-                           return timed_sub_normal(x, y);
-                       }});
-    palette.push_back({"branch_taken", [](unsigned, unsigned) {
-                           return timed_branch_taken(1000000);
-                       }});
-    palette.push_back({"branch_random", [](unsigned, unsigned) {
-                           return timed_branch_random(1000000);
-                       }});
-    palette.push_back({"branch_not_taken", [](unsigned, unsigned) {
-                           return timed_branch_not_taken(1000000);
-                       }});
-    palette.push_back(
-        {"mem_seq", [](unsigned, unsigned) { return timed_mem_seq(1000000); }});
-
-    palette.push_back({"mem_random", [](unsigned, unsigned) {
-                           return timed_mem_random(1000000);
-                       }});
-
-    //    auto plan = greedy_schedule(palette, a, b, /*steps=*/6);
+    auto prof = mintime::profile();
+    std::cout << "mem_latency cycles_per_load=" << prof.mem_latency_cycles
+              << "\n";
+
+    mintime::Runner runner(a, b);
+    runner.add_default_palette(prof);
+
+    //    auto plan = greedy_schedule(runner.palette(), a, b, /*steps=*/6);
 
     CSVLogger logger("results.csv");
-    for (auto &operation : palette) {
-        uint64_t cycles = operation.run(a, b);
-        logger.log(operation.name, (a + b + 1) * 1000000, cycles);
-        std::cout << operation.name << " cycles=" << cycles << "\n";
-    }
+    runner.run_all([&](const mintime::Result &r) {
+        logger.log(r.name, r.iters, r.cycles);
+        std::cout << r.name << " cycles=" << r.cycles << "\n";
+    });
 
     return 0;
 }
@@ -0,0 +1,181 @@
+#include "mintime.hpp"
+#include "operations.hpp"
+#include "os_ops.hpp"
+#include "timing.hpp"
+#include <algorithm>
+#include <xmmintrin.h>
+
+namespace mintime {
+
+/*
+** The FP kernels clear FTZ/DAZ to reach the subnormal slow path. That is fine
+** for the CLI but not for a host process, so put the caller's MXCSR back.
+*/
+namespace {
+struct MxcsrGuard {
+    unsigned saved = _mm_getcsr();
+    ~MxcsrGuard() { _mm_setcsr(saved); }
+};
+
+template <int N, typename F> uint64_t median_of(F &&f) {
+    uint64_t v[N];
+    for (int i = 0; i < N; i++)
+        v[i] = f();
+    std::sort(v, v + N);
+    return v[N / 2];
+}
+} // namespace
+
+/**
+ * @brief Probes the system to measure the performance of different arithmetic
+ * operations.
+ *
+ * This function calculates the median time taken for slow and fast addition and
+ * multiplication.
+ *
+ * @param a An unsigned integer used as input for the timed operations.
+ * @param b An unsigned integer used as input for the timed operations.
+ * @return A SubnormalProbe containing the median times for the four
+ * operations.
+ */
+SubnormalProbe probe(unsigned a, unsigned b) {
+    MxcsrGuard guard;
+    SubnormalProbe m;
+    m.add_slow = median_of<9>([&]() { return timed_add_subnormal(a, b); });
+    m.add_fast = median_of<9>([&]() { return timed_add_normal(a, b); });
+    m.mul_slow = median_of<9>([&]() { return timed_mul_subnormal(a, b); });
+    m.mul_fast = median_of<9>([&]() { return timed_mul_normal(a, b); });
+    return m;
+}
+
+/**
+ * @brief Builds the full machine profile used by the CLI.
+ *
+ * @return A Profile from the CPUID heuristics, probe(50, 50) and a pointer
+ * chase over 16384 lines spread across 64 MiB, one per 4 KiB page.
+ */
+Profile profile() {
+    Profile p;
+    uint64_t t0 = tsc_start();
+    p.cpu = get_cpu_info();
+    p.machine = profile_from_cpu(p.cpu);
+    p.subnormal = probe(50, 50);
+    p.has_slow_subnormals = p.subnormal.slow() || p.machine.has_slow_subnormals;
+
+    const size_t nodes = 1u << 14;
+    p.mem_latency_cycles =
+        static_cast<double>(median_of<3>(
+            [&]() { return timed_mem_chase(64u << 20, nodes); })) /
+        nodes;
+    p.probe_cycles = tsc_stop() - t0;
+    return p;
+}
+
+/**
+ * @brief Builds a machine profile within a few milliseconds.
+ *
+ * The FP kernels run 10k iterations (median of three) instead of (a + b + 1)
+ * million, and memory latency comes from one lap over 2048 lines spread across
+ * the same 64 MiB as profile(), one per 32 KiB: as many page faults as a
+ * denser buffer, but enough pages that the TLB and page-walk caches miss.
+ *
+ * @return A Profile with the same fields as profile().
+ */
+Profile quick_profile() {
+    const unsigned iters = 10000;
+    Profile p;
+    uint64_t t0 = tsc_start();
+    p.cpu = get_cpu_info();
+    p.machine = profile_from_cpu(p.cpu);
+    {
+        MxcsrGuard guard;
+        p.subnormal.add_slow =
+            median_of<3>([&]() { return timed_add_subnormal_n(iters); });
+        p.subnormal.add_fast =
+            median_of<3>([&]() { return timed_add_normal_n(iters); });
+        p.subnormal.mul_slow =
+            median_of<3>([&]() { return timed_mul_subnormal_n(iters); });
+        p.subnormal.mul_fast =
+            median_of<3>([&]() { return timed_mul_normal_n(iters); });
+    }
+    p.has_slow_subnormals = p.subnormal.slow() || p.machine.has_slow_subnormals;
+
+    const size_t nodes = 2048;
+    p.mem_latency_cycles =
+        static_cast<double>(timed_mem_chase(64u << 20, nodes)) / nodes;
+    p.probe_cycles = tsc_stop() - t0;
+    return p;
+}
+
+void Runner::add_default_palette(const Profile &prof) {
+    if (prof.has_slow_subnormals) {
+        add({"add_slow", [](unsigned x, unsigned y) {
+                 return timed_add_subnormal(x, y);
+             }});
+        add({"mul_slow", [](unsigned x, unsigned y) {
+                 return timed_mul_subnormal(x, y);
+             }});
+        add({"sub_slow", [](unsigned x, unsigned y) {
+                 return timed_sub_subnormal(x, y);
+             }});
+    }
+    add({"add_fast",
+         [](unsigned x, unsigned y) { return timed_add_normal(x, y); }});
+    add({"mul_fast",
+         [](unsigned x, unsigned y) { return timed_mul_normal(x, y); }});
+    add({"sub_fast",
+         [](unsigned x, unsigned y) { return timed_sub_normal(x, y); }});
+    add({"branch_taken",
+         [](unsigned, unsigned) { return timed_branch_taken(1000000); }});
+    add({"branch_random",
+         [](unsigned, unsigned) { return timed_branch_random(1000000); }});
+    add({"branch_not_taken",
+         [](unsigned, unsigned) { return timed_branch_not_taken(1000000); }});
+    add({"mem_seq", [](unsigned, unsigned) { return timed_mem_seq(1000000); }});
+    add({"mem_random",
+         [](unsigned, unsigned) { return timed_mem_random(1000000); }});
+
+#ifdef __linux__
+    add({"os_getppid",
+         [](unsigned, unsigned) { return timed_syscall_getppid(100000); },
+         100000});
+    add({"os_clock_gettime",
+         [](unsigned, unsigned) { return timed_clock_gettime(1000000); },
+         1000000});
+    add({"os_fault_4k",
+         [](unsigned, unsigned) { return timed_page_fault_4k(16384); }, 16384});
+    add({"os_fault_2m",
+         [](unsigned, unsigned) { return timed_page_fault_2m(32); }, 32});
+    add({"os_mmap_munmap",
+         [](unsigned, unsigned) { return timed_mmap_munmap(10000); }, 10000});
+    add({"os_futex_rtt",
+         [](unsigned, unsigned) { return timed_futex_roundtrip(10000); },
+         10000});
+    add({"os_pipe_switch",
+         [](unsigned, unsigned) { return timed_pipe_switch(10000); }, 10000});
+#endif
+}
+
+Result Runner::run(const Benchmark &bench) const {
+    MxcsrGuard guard;
+    Result r;
+    r.name = bench.name;
+    r.iters = bench.iters ? bench.iters
+                          : static_cast<uint64_t>(a_ + b_ + 1) * 1000000;
+    r.cycles = bench.run(a_, b_);
+    return r;
+}
+
+std::vector<Result>
+Runner::run_all(const std::function<void(const Result &)> &on_result) const {
+    std::vector<Result> results;
+    results.reserve(palette_.size());
+    for (auto &bench : palette_) {
+        results.push_back(run(bench));
+        if (on_result)
+            on_result(results.back());
+    }
+    return results;
+}
+
+} // namespace mintime
@@ -0,0 +1,117 @@
+#ifndef MINTIME_H_
+#define MINTIME_H_
+
+#include "alloc_bench.hpp"
+#include "canary.hpp"
+#include "cpuinfo.hpp"
+#include "int_ops.hpp"
+#include "scheduler.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+** Public API of the mintime_core library.
+**
+** Everything the mintime CLI does is reachable from here, so services can run
+** the same probes in-process (e.g. at startup, to decide whether to enable FTZ
+** or which prefetch distance to use) without shelling out to the binary.
+*/
+namespace mintime {
+
+using ::AllocRow;
+using ::CanaryConfig;
+using ::CPUInfo;
+using ::IntOpRow;
+using ::MachineProfile;
+using ::alloc_table;
+using ::int_op_table;
+using ::run_canary;
+
+/*
+** A named timed operation; run(a, b) returns elapsed TSC cycles over `iters`
+** repetitions.
+*/
+using Benchmark = ::TimedOperations;
+
+struct Result {
+    std::string name;
+    uint64_t iters = 0;
+    uint64_t cycles = 0;
+
+    double cycles_per_iter() const {
+        return iters ? static_cast<double>(cycles) / static_cast<double>(iters)
+                     : 0.0;
+    }
+};
+
+/* Median cycles of the normal and subnormal FP kernels. */
+struct SubnormalProbe {
+    uint64_t add_slow = 0, add_fast = 0, mul_slow = 0, mul_fast = 0;
+
+    bool slow() const {
+        return (add_slow > add_fast * 2) || (mul_slow > mul_fast * 2);
+    }
+};
+
+struct Profile {
+    CPUInfo cpu;
+    MachineProfile machine{};
+    SubnormalProbe subnormal;
+    /* Measured slowdown or vendor heuristic, whichever says "slow". */
+    bool has_slow_subnormals = false;
+    /* Cycles per dependent load that misses the caches and the TLB. */
+    double mem_latency_cycles = 0.0;
+    /* TSC cycles spent producing this profile. */
+    uint64_t probe_cycles = 0;
+};
+
+/*
+** probe(a, b) -> SubnormalProbe
+**
+** Median of nine runs of each add/mul kernel at (a + b + 1) * 1M iterations.
+** The caller's MXCSR is restored before returning.
+*/
+SubnormalProbe probe(unsigned a, unsigned b);
+
+/*
+** profile() -> Profile
+**
+** The profile the CLI uses to build its palette. Takes on the order of
+** seconds; use quick_profile() on a service's startup path.
+*/
+Profile profile();
+
+/*
+** quick_profile() -> Profile
+**
+** Same fields as profile(), from short kernels and a single lap of a sparse
+** pointer chase. Bounded to a few milliseconds on current hardware; the
+** actual cost is reported in probe_cycles.
+*/
+Profile quick_profile();
+
+class Runner {
+    unsigned a_, b_;
+    std::vector<Benchmark> palette_;
+
+  public:
+    explicit Runner(unsigned a = 10, unsigned b = 20) : a_(a), b_(b) {}
+
+    void add(Benchmark bench) { palette_.push_back(std::move(bench)); }
+
+    /* The arithmetic, branch, memory and (on Linux) OS palette the CLI runs. */
+    void add_default_palette(const Profile &prof);
+
+    const std::vector<Benchmark> &palette() const { return palette_; }
+
+    Result run(const Benchmark &bench) const;
+
+    std::vector<Result>
+    run_all(const std::function<void(const Result &)> &on_result = {}) const;
+};
+
+} // namespace mintime
+
+#endif // MINTIME_H_
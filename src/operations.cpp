@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <limits>
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -15,6 +16,10 @@
 #endif
 #include <xmmintrin.h>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 /*
 **
 **
@@ -42,9 +47,8 @@ static inline double make_subnormal() {
 
 static inline double make_normal() { return 1.0; };
 
-uint64_t timed_add_subnormal(unsigned a, unsigned b) {
+uint64_t timed_add_subnormal_n(unsigned iters) {
     fp_enable_subnormal_slowpath();
-    const unsigned iters = (a + b + 1) * 1000000u;
 
     double slow = make_subnormal();
     volatile double acc = 1.1;
@@ -65,10 +69,12 @@ uint64_t timed_add_subnormal(unsigned a, unsigned b) {
     return t1 - t0;
 }
 
-uint64_t timed_add_normal(unsigned a, unsigned b) {
-    fp_enable_subnormal_slowpath();
+uint64_t timed_add_subnormal(unsigned a, unsigned b) {
+    return timed_add_subnormal_n((a + b + 1) * 1000000u);
+}
 
-    const unsigned iters = (a + b + 1) * 1000000u;
+uint64_t timed_add_normal_n(unsigned iters) {
+    fp_enable_subnormal_slowpath();
 
     volatile double fast = make_normal();
     volatile double acc = 1.1;
@@ -96,9 +102,12 @@ uint64_t timed_add_normal(unsigned a, unsigned b) {
     return t1 - t0;
 }
 
-uint64_t timed_mul_subnormal(unsigned a, unsigned b) {
+uint64_t timed_add_normal(unsigned a, unsigned b) {
+    return timed_add_normal_n((a + b + 1) * 1000000u);
+}
+
+uint64_t timed_mul_subnormal_n(unsigned iters) {
     fp_enable_subnormal_slowpath();
-    const unsigned iters = (a + b + 1) * 1000000u;
 
     double slow = make_subnormal();
     volatile double acc = 1.1;
@@ -126,10 +135,12 @@ uint64_t timed_mul_subnormal(unsigned a, unsigned b) {
     return t1 - t0;
 }
 
-uint64_t timed_mul_normal(unsigned a, unsigned b) {
-    fp_enable_subnormal_slowpath();
+uint64_t timed_mul_subnormal(unsigned a, unsigned b) {
+    return timed_mul_subnormal_n((a + b + 1) * 1000000u);
+}
 
-    const unsigned iters = (a + b + 1) * 1000000u;
+uint64_t timed_mul_normal_n(unsigned iters) {
+    fp_enable_subnormal_slowpath();
 
     volatile double fast = 1.0;
     volatile double acc = 1.1;
@@ -153,6 +164,10 @@ uint64_t timed_mul_normal(unsigned a, unsigned b) {
     return t1 - t0;
 }
 
+uint64_t timed_mul_normal(unsigned a, unsigned b) {
+    return timed_mul_normal_n((a + b + 1) * 1000000u);
+}
+
 uint64_t timed_sub_normal(unsigned a, unsigned b) {
     volatile float x = static_cast<float>(a);
     volatile float y = static_cast<float>(b);
@@ -295,3 +310,48 @@ uint64_t timed_mem_random(size_t N) {
 #endif
     return t1 - t0;
 }
+
+uint64_t timed_mem_chase(size_t bytes, size_t nodes) {
+    const size_t words = bytes / sizeof(size_t);
+    const size_t line = 64 / sizeof(size_t);
+    const size_t stride = std::max(words / nodes, line) / line * line;
+    nodes = std::min(nodes, words / stride);
+
+    // Left uninitialised on purpose: only the visited lines get faulted in.
+    std::unique_ptr<size_t[]> buf(new size_t[words]);
+#ifdef __linux__
+    // With THP=always the nodes would share 2 MiB pages and hit in the TLB.
+    const uintptr_t page = 4096;
+    uintptr_t lo =
+        (reinterpret_cast<uintptr_t>(buf.get()) + page - 1) & ~(page - 1);
+    uintptr_t hi =
+        reinterpret_cast<uintptr_t>(buf.get() + words) & ~(page - 1);
+    if (hi > lo)
+        madvise(reinterpret_cast<void *>(lo), hi - lo, MADV_NOHUGEPAGE);
+#endif
+    std::vector<size_t> order(nodes);
+    for (size_t i = 0; i < nodes; i++)
+        order[i] = i * stride;
+
+    std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+    for (size_t i = 0; i < nodes; i++)
+        buf[order[i]] = order[(i + 1) % nodes];
+    for (size_t i = 0; i < nodes; i++)
+        _mm_clflush(&buf[order[i]]);
+    _mm_mfence();
+
+    size_t p = order[0];
+    uint64_t t0 = tsc_start();
+    for (size_t i = 0; i < nodes; i++) {
+        p = buf[p];
+    }
+
+    uint64_t t1 = tsc_stop();
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+#else
+    asm volatile("" ::"r"(p));
+#endif
+    return t1 - t0;
+}
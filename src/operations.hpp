@@ -4,6 +4,10 @@
 #include <cstdint>
 #include <stddef.h>
 
+uint64_t timed_add_subnormal_n(unsigned iters);
+uint64_t timed_add_normal_n(unsigned iters);
+uint64_t timed_mul_subnormal_n(unsigned iters);
+uint64_t timed_mul_normal_n(unsigned iters);
 uint64_t timed_add_subnormal(unsigned a, unsigned b);
 uint64_t timed_add_normal(unsigned a, unsigned b);
 uint64_t timed_mul_subnormal(unsigned a, unsigned b);
@@ -15,5 +19,6 @@ uint64_t timed_branch_random(int iters);
 uint64_t timed_branch_not_taken(int iters);
 uint64_t timed_mem_seq(size_t N);
 uint64_t timed_mem_random(size_t N);
+uint64_t timed_mem_chase(size_t bytes, size_t nodes);
 
 #endif // STALL_ADD_H_
@@ -0,0 +1,197 @@
+#include "os_ops.hpp"
+#include "timing.hpp"
+
+#ifdef __linux__
+
+#include <atomic>
+#include <ctime>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+/*
+** timed_syscall_getppid(iters) -> uint64_t
+**
+** Issued through syscall() so libc cannot answer from a cache; this is the
+** round trip into the kernel, including any KPTI/retpoline entry cost.
+*/
+uint64_t timed_syscall_getppid(int iters) {
+    volatile long r = 0;
+    uint64_t t0 = tsc_start();
+    for (int i = 0; i < iters; i++) {
+        r = syscall(SYS_getppid);
+    }
+    uint64_t t1 = tsc_stop();
+    asm volatile("" ::"r"(r));
+    return t1 - t0;
+}
+
+/*
+** timed_clock_gettime(iters) -> uint64_t
+**
+** CLOCK_MONOTONIC is served by the vDSO when the clocksource allows it; a
+** result close to the getppid figure means the kernel fell back to a syscall.
+*/
+uint64_t timed_clock_gettime(int iters) {
+    struct timespec ts;
+    uint64_t t0 = tsc_start();
+    for (int i = 0; i < iters; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        asm volatile("" ::"r"(&ts) : "memory");
+    }
+    uint64_t t1 = tsc_stop();
+    return t1 - t0;
+}
+
+/*
+** Touches the first byte of each `page`-sized page of a fresh anonymous
+** mapping and returns the cycles spent in the resulting faults. `advice` is
+** MADV_NOHUGEPAGE or MADV_HUGEPAGE; the mapping is over-allocated so it can
+** be aligned to a 2 MiB boundary.
+*/
+static uint64_t timed_first_touch(size_t pages, size_t page, int advice) {
+    const size_t huge = 2u << 20;
+    const size_t len = pages * page;
+    char *raw = static_cast<char *>(mmap(nullptr, len + huge,
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED)
+        return 0;
+    char *base = reinterpret_cast<char *>(
+        (reinterpret_cast<uintptr_t>(raw) + huge - 1) & ~(huge - 1));
+    madvise(base, len, advice);
+
+    uint64_t t0 = tsc_start();
+    for (size_t i = 0; i < pages; i++) {
+        *static_cast<volatile char *>(base + i * page) = 1;
+    }
+    uint64_t t1 = tsc_stop();
+
+    munmap(raw, len + huge);
+    return t1 - t0;
+}
+
+uint64_t timed_page_fault_4k(size_t pages) {
+    return timed_first_touch(pages, 4096, MADV_NOHUGEPAGE);
+}
+
+/*
+** Needs transparent huge pages in "madvise" or "always" mode. Without them
+** each touch faults in a single 4 KiB page, which shows up as an implausibly
+** small figure.
+*/
+uint64_t timed_page_fault_2m(size_t pages) {
+    return timed_first_touch(pages, 2u << 20, MADV_HUGEPAGE);
+}
+
+uint64_t timed_mmap_munmap(int iters) {
+    uint64_t t0 = tsc_start();
+    for (int i = 0; i < iters; i++) {
+        void *p = mmap(nullptr, 4096, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        munmap(p, 4096);
+    }
+    uint64_t t1 = tsc_stop();
+    return t1 - t0;
+}
+
+static long futex(std::atomic<int> *word, int op, int val) {
+    return syscall(SYS_futex, reinterpret_cast<int *>(word), op, val, nullptr,
+                   nullptr, 0);
+}
+
+/*
+** timed_futex_roundtrip(iters) -> uint64_t
+**
+** Ping-pong on one futex word between this thread and a helper: 1 hands the
+** turn to the helper, 0 hands it back. Each iteration is one wake and one
+** wait in each direction.
+*/
+uint64_t timed_futex_roundtrip(int iters) {
+    std::atomic<int> word{0};
+
+    std::thread peer([&]() {
+        for (int i = 0; i < iters; i++) {
+            while (word.load(std::memory_order_acquire) == 0)
+                futex(&word, FUTEX_WAIT_PRIVATE, 0);
+            word.store(0, std::memory_order_release);
+            futex(&word, FUTEX_WAKE_PRIVATE, 1);
+        }
+    });
+
+    uint64_t t0 = tsc_start();
+    for (int i = 0; i < iters; i++) {
+        word.store(1, std::memory_order_release);
+        futex(&word, FUTEX_WAKE_PRIVATE, 1);
+        while (word.load(std::memory_order_acquire) == 1)
+            futex(&word, FUTEX_WAIT_PRIVATE, 1);
+    }
+    uint64_t t1 = tsc_stop();
+
+    peer.join();
+    return t1 - t0;
+}
+
+/*
+** timed_pipe_switch(iters) -> uint64_t
+**
+** One byte bounced through a pair of pipes between two threads, as in
+** lmbench's lat_ctx. Both threads are pinned to the CPU the caller is running
+** on, so each iteration is two context switches rather than two cross-core
+** wakeups; the caller's affinity mask is restored afterwards. Returns 0 if
+** the pipes or the pinning cannot be set up.
+*/
+uint64_t timed_pipe_switch(int iters) {
+    cpu_set_t saved, one;
+    const int cpu = sched_getcpu();
+    if (cpu < 0 ||
+        pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) != 0)
+        return 0;
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+    // The peer is created after this and inherits the single-CPU mask.
+    if (pthread_setaffinity_np(pthread_self(), sizeof(one), &one) != 0)
+        return 0;
+
+    int ping[2], pong[2];
+    if (pipe(ping) != 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+        return 0;
+    }
+    if (pipe(pong) != 0) {
+        close(ping[0]);
+        close(ping[1]);
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+        return 0;
+    }
+
+    std::thread peer([&]() {
+        char c;
+        for (int i = 0; i < iters; i++) {
+            if (read(ping[0], &c, 1) != 1 || write(pong[1], &c, 1) != 1)
+                break;
+        }
+    });
+
+    char c = 'x';
+    uint64_t t0 = tsc_start();
+    for (int i = 0; i < iters; i++) {
+        if (write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1)
+            break;
+    }
+    uint64_t t1 = tsc_stop();
+
+    peer.join();
+    close(ping[0]);
+    close(ping[1]);
+    close(pong[0]);
+    close(pong[1]);
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    return t1 - t0;
+}
+
+#endif // __linux__
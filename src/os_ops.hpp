@@ -0,0 +1,20 @@
+#ifndef OS_OPS_H_
+#define OS_OPS_H_
+
+#include <cstdint>
+#include <stddef.h>
+
+/*
+** Kernel-level costs, timed with the same tsc_start()/tsc_stop() harness as
+** the CPU operations. Each function returns the total cycles for `iters`
+** repetitions (or `pages` faults). Linux only.
+*/
+uint64_t timed_syscall_getppid(int iters);
+uint64_t timed_clock_gettime(int iters);
+uint64_t timed_page_fault_4k(size_t pages);
+uint64_t timed_page_fault_2m(size_t pages);
+uint64_t timed_mmap_munmap(int iters);
+uint64_t timed_futex_roundtrip(int iters);
+uint64_t timed_pipe_switch(int iters);
+
+#endif // OS_OPS_H_
@@ -4,11 +4,13 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include <cstdint>
 struct TimedOperations {
     std::string name;
     std::function<uint64_t(unsigned, unsigned)> run;
+    uint64_t iters = 0; // 0: (a + b + 1) * 1000000
 };
 
 struct GreedyPlan {